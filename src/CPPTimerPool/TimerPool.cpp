@@ -35,6 +35,7 @@
 
 #include "TimerPool.hpp"
 
+#include <cassert>
 #include <vector>
 
 #if defined(_WIN32)
@@ -85,27 +86,55 @@ namespace
         pthread_setname_np(name.c_str());
 #endif
     }
+
+    // Thread-affine pools and their timers are only ever used from their owning
+    // thread, so their locks are skipped entirely and the returned lock is empty.
+    std::unique_lock<std::mutex> LockUnlessThreadAffine(std::mutex& mutex, std::thread::id ownerThread)
+    {
+        if (ownerThread != std::thread::id())
+            return std::unique_lock<std::mutex>(mutex, std::defer_lock);
+
+        return std::unique_lock<std::mutex>(mutex);
+    }
+
+    void AssertOwningThread(std::thread::id ownerThread)
+    {
+        assert(ownerThread == std::thread::id() || ownerThread == std::this_thread::get_id());
+        (void)ownerThread;
+    }
 }
 
 
 TimerPool::PoolHandle TimerPool::Create(const std::string& name)
 {
-    return std::make_shared<TimerPool>(PrivateConstructOnlyTag{}, name);
+    return std::make_shared<TimerPool>(PrivateConstructOnlyTag{}, name, std::thread::id());
 }
 
-TimerPool::TimerPool(const PrivateConstructOnlyTag&, const std::string& name)
+TimerPool::PoolHandle TimerPool::CreateForCurrentThread(const std::string& name)
+{
+    return std::make_shared<TimerPool>(PrivateConstructOnlyTag{}, name, std::this_thread::get_id());
+}
+
+TimerPool::TimerPool(const PrivateConstructOnlyTag&, const std::string& name, std::thread::id ownerThread)
     : m_mutex{ }
     , m_name{ name }
+    , m_ownerThread{ ownerThread }
+    , m_timerExpiries{ }
     , m_timers{ }
     , m_running{ true }
+    , m_sleepUntil{ Clock::time_point::min() }
     , m_cond{ }
-    , m_thread{ [this]() { run(); } }
+    , m_thread{ }
 {
-
+    // Thread-affine pools have no thread of their own, they are driven by the owner via poll().
+    if (! threadAffine())
+        m_thread = std::thread([this]() { run(); });
 }
 
 TimerPool::~TimerPool()
 {
+    AssertOwningThread(m_ownerThread);
+
     stop();
 
     if (m_thread.joinable())
@@ -114,25 +143,107 @@ TimerPool::~TimerPool()
 
 void TimerPool::registerTimer(TimerHandle timer)
 {
+    // Timers can only be stored in the pool that owns them, as they publish their expiry changes to it.
+    assert(timer->pool().get() == this);
+    if (timer->pool().get() != this)
+        return;
+
+    AssertOwningThread(m_ownerThread);
+
     {
-        std::lock_guard<decltype(m_mutex)> lock(m_mutex);
+        // Lock order is always timer then pool, matching the timer's own expiry updates.
+        const auto timerLock = LockUnlessThreadAffine(timer->m_mutex, timer->m_ownerThread);
+        const auto lock = LockUnlessThreadAffine(m_mutex, m_ownerThread);
 
-        m_timers.remove(timer);
-        m_timers.emplace_front(timer);
+        if (timer->m_poolSlot == kInvalidSlot)
+        {
+            timer->m_poolSlot = m_timers.size();
+
+            m_timerExpiries.emplace_back(timer->m_nextExpiry);
+            m_timers.emplace_back(timer);
+        }
+        else
+        {
+            m_timerExpiries[timer->m_poolSlot] = timer->m_nextExpiry;
+        }
     }
 
-    m_cond.notify_all();
+    wake();
 }
 
 void TimerPool::unregisterTimer(TimerHandle timer)
 {
+    // A foreign timer's slot refers to its own pool's storage, not ours.
+    assert(timer->pool().get() == this);
+    if (timer->pool().get() != this)
+        return;
+
+    AssertOwningThread(m_ownerThread);
+
     {
-        std::lock_guard<decltype(m_mutex)> lock(m_mutex);
+        const auto lock = LockUnlessThreadAffine(m_mutex, m_ownerThread);
 
-        m_timers.remove(timer);
+        const auto slot = timer->m_poolSlot;
+        if (slot == kInvalidSlot || m_timers[slot] != timer)
+            return;
+
+        // Keep the storage dense by moving the last timer into the vacated slot.
+        const auto lastSlot = m_timers.size() - 1;
+        if (slot != lastSlot)
+        {
+            m_timerExpiries[slot] = m_timerExpiries[lastSlot];
+            m_timers[slot] = std::move(m_timers[lastSlot]);
+            m_timers[slot]->m_poolSlot = slot;
+        }
+
+        m_timerExpiries.pop_back();
+        m_timers.pop_back();
+
+        timer->m_poolSlot = kInvalidSlot;
     }
 
-    m_cond.notify_all();
+    wake();
+}
+
+void TimerPool::updateTimerExpiry(const Timer& timer, Clock::time_point expiry)
+{
+    const auto lock = LockUnlessThreadAffine(m_mutex, m_ownerThread);
+
+    if (timer.m_poolSlot == kInvalidSlot)
+        return;
+
+    m_timerExpiries[timer.m_poolSlot] = expiry;
+
+    // Only wake the pool thread if it is asleep and would otherwise oversleep this timer. Waking it
+    // on every change would force a full rescan with the pool lock held, stalling every other thread
+    // that is (re)starting or stopping timers in the pool for the length of that scan.
+    if (expiry < m_sleepUntil)
+        m_cond.notify_all();
+}
+
+TimerPool::Clock::time_point TimerPool::earliestTimerExpiry() const noexcept
+{
+    // Reduce the dense deadline array with a branch-free loop. This is a tight scalar loop at -O2; it is
+    // only vectorized at -O3 when targeting a CPU with 64-bit vector compares (e.g. -march=x86-64-v2).
+    auto earliestTicks = Clock::time_point::max().time_since_epoch().count();
+
+    for (const auto& expiryTime : m_timerExpiries)
+    {
+        const auto expiryTicks = expiryTime.time_since_epoch().count();
+
+        earliestTicks = (expiryTicks < earliestTicks) ? expiryTicks : earliestTicks;
+    }
+
+    return Clock::time_point(Clock::duration(earliestTicks));
+}
+
+void TimerPool::collectExpiredTimers(Clock::time_point now, std::vector<TimerHandle>& expiredTimers) const
+{
+    for (std::size_t slot = 0; slot < m_timerExpiries.size(); slot++)
+    {
+        if (m_timerExpiries[slot] <= now)
+            expiredTimers.emplace_back(m_timers[slot]);
+    }
 }
 
 void TimerPool::run()
@@ -156,15 +267,14 @@ void TimerPool::run()
 
         auto wakeTime = nowTime + std::chrono::minutes(1);
 
-        for (const auto& timer : m_timers)
-        {
-            const auto expiryTime = timer->nextExpiry();
+        // Most passes find nothing due, so first find the earliest expiry and only go back to gather
+        // the expired timers if there are any.
+        const auto earliestExpiry = earliestTimerExpiry();
 
-            if (expiryTime <= nowTime)
-                expiredTimers.emplace_back(timer);
-            else if (expiryTime < wakeTime)
-                wakeTime = expiryTime;
-        }
+        if (earliestExpiry <= nowTime)
+            collectExpiredTimers(nowTime, expiredTimers);
+        else if (earliestExpiry < wakeTime)
+            wakeTime = earliestExpiry;
 
         if (! expiredTimers.empty())
         {
@@ -177,34 +287,78 @@ void TimerPool::run()
             lock.unlock();
 
             for (const auto& timer : expiredTimers)
-                timer->fire(nowTime);
+                timer->fire(nowTime, this, true);
 
             expiredTimers.clear();
         }
         else
         {
-            // No timers have expired yet, we can sleep.
+            // No timers have expired yet, we can sleep. The running flag must be re-checked with the lock
+            // held, otherwise a stop() that lands between the loop test and the lock is missed until the
+            // wake time elapses.
 
-            m_cond.wait_until(lock, wakeTime);
+            if (m_running)
+            {
+                m_sleepUntil = wakeTime;
+                m_cond.wait_until(lock, wakeTime);
+                m_sleepUntil = Clock::time_point::min();
+            }
         }
     }
 }
 
 void TimerPool::stop()
 {
+    AssertOwningThread(m_ownerThread);
+
     {
-        std::lock_guard<decltype(m_mutex)> lock(m_mutex);
+        const auto lock = LockUnlessThreadAffine(m_mutex, m_ownerThread);
 
         m_running = false;
+
+        for (const auto& timer : m_timers)
+            timer->m_poolSlot = kInvalidSlot;
+
+        m_timerExpiries.clear();
         m_timers.clear();
     }
 
-    m_cond.notify_all();
+    wake();
+}
+
+TimerPool::Clock::time_point TimerPool::poll()
+{
+    AssertOwningThread(m_ownerThread);
+    assert(threadAffine());
+
+    if (! threadAffine() || ! m_running)
+        return Clock::time_point::max();
+
+    // Keep ourselves alive in case a callback drops the last external reference to the pool.
+    const auto selfHandle = shared_from_this();
+
+    const auto nowTime = Clock::now();
+
+    if (earliestTimerExpiry() <= nowTime)
+    {
+        // Expired timers are gathered locally, so that callbacks may safely call poll() again.
+        std::vector<TimerHandle> expiredTimers;
+        collectExpiredTimers(nowTime, expiredTimers);
+
+        for (const auto& timer : expiredTimers)
+            timer->fire(nowTime, this, true);
+    }
+
+    // Callbacks may have rescheduled or stopped timers, so report the updated earliest expiry for the
+    // owner to wait until.
+    return m_running ? earliestTimerExpiry() : Clock::time_point::max();
 }
 
 void TimerPool::wake()
 {
-    m_cond.notify_all();
+    // Thread-affine pools are only polled by their owner, there is no pool thread to wake.
+    if (! threadAffine())
+        m_cond.notify_all();
 }
 
 // ==================
@@ -220,7 +374,9 @@ TimerPool::Timer::TimerHandle TimerPool::Timer::Create(const PoolHandle& pool, c
 TimerPool::Timer::Timer(const PrivateConstructOnlyTag&, const PoolHandle& pool, const std::string& name)
     : m_pool{ pool }
     , m_name{ name }
+    , m_ownerThread{ pool ? pool->m_ownerThread : std::thread::id() }
     , m_nextExpiry{ Clock::time_point::max() }
+    , m_poolSlot{ TimerPool::kInvalidSlot }
     , m_callback{ nullptr }
     , m_interval{ 0 }
     , m_repeated{ false }
@@ -230,29 +386,39 @@ TimerPool::Timer::Timer(const PrivateConstructOnlyTag&, const PoolHandle& pool,
 
 void TimerPool::Timer::setCallback(Callback callback)
 {
-    std::lock_guard<decltype(m_mutex)> lock(m_mutex);
+    AssertOwningThread(m_ownerThread);
+
+    const auto lock = LockUnlessThreadAffine(m_mutex, m_ownerThread);
 
     m_callback = std::move(callback);
 }
 
 void TimerPool::Timer::setInterval(std::chrono::milliseconds ms)
 {
-    std::lock_guard<decltype(m_mutex)> lock(m_mutex);
+    AssertOwningThread(m_ownerThread);
+
+    const auto lock = LockUnlessThreadAffine(m_mutex, m_ownerThread);
 
     m_interval = ms;
 }
 
 void TimerPool::Timer::setRepeated(bool repeated)
 {
-    std::lock_guard<decltype(m_mutex)> lock(m_mutex);
+    AssertOwningThread(m_ownerThread);
+
+    const auto lock = LockUnlessThreadAffine(m_mutex, m_ownerThread);
 
     m_repeated = repeated;
 }
 
 void TimerPool::Timer::start(StartMode mode)
 {
+    AssertOwningThread(m_ownerThread);
+
+    const auto pool = m_pool.lock();
+
     {
-        std::lock_guard<decltype(m_mutex)> lock(m_mutex);
+        const auto lock = LockUnlessThreadAffine(m_mutex, m_ownerThread);
 
         switch (mode)
         {
@@ -282,32 +448,50 @@ void TimerPool::Timer::start(StartMode mode)
         }
 
         m_nextExpiry = Clock::now() + m_interval;
-    }
 
-    if (const auto& pool = m_pool.lock())
-        pool->wake();
+        if (pool)
+            pool->updateTimerExpiry(*this, m_nextExpiry);
+    }
 }
 
 void TimerPool::Timer::stop()
 {
+    AssertOwningThread(m_ownerThread);
+
+    const auto pool = m_pool.lock();
+
     {
-        std::lock_guard<decltype(m_mutex)> lock(m_mutex);
+        const auto lock = LockUnlessThreadAffine(m_mutex, m_ownerThread);
 
         m_nextExpiry = Clock::time_point::max();
-    }
 
-    if (const auto& pool = m_pool.lock())
-        pool->wake();
+        if (pool)
+            pool->updateTimerExpiry(*this, m_nextExpiry);
+    }
 }
 
 void TimerPool::Timer::fire(Clock::time_point now)
 {
+    const auto pool = m_pool.lock();
+
+    fire(now, pool.get(), false);
+}
+
+void TimerPool::Timer::fire(Clock::time_point now, TimerPool* pool, bool expiredOnly)
+{
+    AssertOwningThread(m_ownerThread);
+
     const auto   selfHandle = shared_from_this();
     unsigned int callbacksRequired = 0;
     Callback     callback;
 
     {
-        std::lock_guard<decltype(m_mutex)> lock(m_mutex);
+        const auto lock = LockUnlessThreadAffine(m_mutex, m_ownerThread);
+
+        // The pool collects expired timers before firing them without its lock held, so the timer
+        // may have been stopped or restarted in the meantime.
+        if (expiredOnly && m_nextExpiry > now)
+            return;
 
         callback = m_callback;
 
@@ -329,6 +513,9 @@ void TimerPool::Timer::fire(Clock::time_point now)
 
             callbacksRequired++;
         }
+
+        if (pool)
+            pool->updateTimerExpiry(*this, m_nextExpiry);
     }
 
     if (callback)
@@ -340,14 +527,18 @@ void TimerPool::Timer::fire(Clock::time_point now)
 
 bool TimerPool::Timer::running() const noexcept
 {
-    std::lock_guard<decltype(m_mutex)> lock(m_mutex);
+    AssertOwningThread(m_ownerThread);
+
+    const auto lock = LockUnlessThreadAffine(m_mutex, m_ownerThread);
 
     return m_nextExpiry != Clock::time_point::max();
 }
 
 TimerPool::Timer::Clock::time_point TimerPool::Timer::nextExpiry() const noexcept
 {
-    std::lock_guard<decltype(m_mutex)> lock(m_mutex);
+    AssertOwningThread(m_ownerThread);
+
+    const auto lock = LockUnlessThreadAffine(m_mutex, m_ownerThread);
 
     return m_nextExpiry;
 }
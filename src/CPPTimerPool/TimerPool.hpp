@@ -38,12 +38,14 @@
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
-#include <forward_list>
+#include <cstddef>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 
 
 class TimerPool final
@@ -63,34 +65,53 @@ public:
 
 public:
     static PoolHandle               Create(const std::string& name = {});
+    static PoolHandle               CreateForCurrentThread(const std::string& name = {});
 
-    explicit                        TimerPool(const PrivateConstructOnlyTag&, const std::string& name);
+    explicit                        TimerPool(const PrivateConstructOnlyTag&, const std::string& name, std::thread::id ownerThread);
                                     ~TimerPool();
 
     TimerPool(const TimerPool&) = delete;
     TimerPool& operator=(const TimerPool&) = delete;
 
-    std::string                     name() const noexcept    { return m_name; }
-    bool                            running() const noexcept { return m_running; }
+    std::string                     name() const noexcept         { return m_name; }
+    bool                            running() const noexcept      { return m_running; }
+    bool                            threadAffine() const noexcept { return m_ownerThread != std::thread::id(); }
 
     void                            stop();
 
+    // Thread-affine pools only: fires expired timers and returns the next expiry. May be called again
+    // from within a timer callback. Asserts in debug builds (and returns time_point::max()) on threaded pools.
+    Clock::time_point               poll();
+
+    // Timers may only be (un)registered with the pool that created them; others are rejected (and assert in debug builds).
     void                            registerTimer(TimerHandle timer);
     void                            unregisterTimer(TimerHandle timer);
 
 private:
+    static constexpr std::size_t    kInvalidSlot = std::numeric_limits<std::size_t>::max();
+
     void                            run();
     void                            wake();
 
+    Clock::time_point               earliestTimerExpiry() const noexcept;
+    void                            collectExpiredTimers(Clock::time_point now, std::vector<TimerHandle>& expiredTimers) const;
+    void                            updateTimerExpiry(const Timer& timer, Clock::time_point expiry);
+
 private:
     mutable std::mutex              m_mutex;
 
     const std::string               m_name;
+    const std::thread::id           m_ownerThread;
 
-    std::forward_list<TimerHandle>  m_timers;
+    // Timer storage is split so that the expiry scan only has to walk a dense array of deadlines,
+    // without chasing each timer's handle or taking its lock. Both arrays are indexed by the timer's
+    // slot; the deadlines are a copy of each timer's own expiry, which the timer keeps up to date.
+    std::vector<Clock::time_point>  m_timerExpiries;
+    std::vector<TimerHandle>        m_timers;
 
     std::atomic<bool>               m_running;
 
+    Clock::time_point               m_sleepUntil;
     std::condition_variable         m_cond;
     std::thread                     m_thread;
 };
@@ -98,6 +119,8 @@ private:
 class TimerPool::Timer final
     : public std::enable_shared_from_this<Timer>
 {
+    friend class TimerPool;
+
 private:
     struct PrivateConstructOnlyTag {};
 
@@ -141,13 +164,18 @@ public:
 
     void                            fire(Clock::time_point now = Clock::time_point::min());
 
+private:
+    void                            fire(Clock::time_point now, TimerPool* pool, bool expiredOnly);
+
 private:
     mutable std::mutex              m_mutex;
 
     const WeakPoolHandle            m_pool;
     const std::string               m_name;
+    const std::thread::id           m_ownerThread;
 
     Clock::time_point               m_nextExpiry;
+    std::size_t                     m_poolSlot; // Guarded by the parent pool's lock, not our own
 
     Callback                        m_callback;
     std::chrono::milliseconds       m_interval;
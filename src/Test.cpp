@@ -35,6 +35,7 @@
 
 #include "TimerPool.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
@@ -171,5 +172,69 @@ int main()
 		}
 	}
 
-	std::this_thread::sleep_for(std::chrono::seconds(10));
+	// TEST 9: Pool is very long lived, middle timer of three is discarded while the others keep running (first and last should run)
+	auto pool9 = TimerPool::Create("Pool 9");
+
+	auto timer11 = TimerPool::Timer::Create(pool9, "EPSILON");
+	timer11->setCallback(kPrintTimerCallback);
+	timer11->setInterval(std::chrono::milliseconds(500));
+	timer11->setRepeated(true);
+	timer11->start();
+
+	if (auto timer12 = TimerPool::Timer::Create(pool9, "Discarded Middle Pool 9 Timer"))
+	{
+		timer12->setCallback(kPrintTimerCallback);
+		timer12->setInterval(std::chrono::milliseconds(500));
+		timer12->setRepeated(true);
+		timer12->start();
+	}
+
+	auto timer13 = TimerPool::Timer::Create(pool9, "ZETA");
+	timer13->setCallback(kPrintTimerCallback);
+	timer13->setInterval(std::chrono::milliseconds(500));
+	timer13->setRepeated(true);
+	timer13->start();
+
+	// TEST 10: Repeating timer is stopped from a sibling's callback when both expire together (victim should run twice, then stop)
+	auto pool10 = TimerPool::Create("Pool 10");
+
+	auto timer14 = TimerPool::Timer::Create(pool10, "Stopper");
+	auto timer15 = TimerPool::Timer::Create(pool10, "ETA");
+
+	timer14->setCallback([timer15](const TimerPool::TimerHandle&) { timer15->stop(); });
+	timer14->setInterval(std::chrono::milliseconds(900));
+
+	timer15->setCallback(kPrintTimerCallback);
+	timer15->setInterval(std::chrono::milliseconds(300));
+	timer15->setRepeated(true);
+
+	timer15->start();
+	timer14->start();
+
+	// TEST 11: Pools with busy timers are repeatedly created and destroyed (should not run, or hang on exit)
+	for (int i = 0; i < 50; i++)
+	{
+		auto pool11 = TimerPool::Create("Pool 11");
+
+		auto timer16 = TimerPool::Timer::Create(pool11, "Busy Pool 11 Timer");
+		timer16->setInterval(std::chrono::milliseconds(1));
+		timer16->setRepeated(true);
+		timer16->start();
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	}
+
+	// TEST 12: Pool is bound to the main thread and driven by its loop below (should run)
+	auto pool12 = TimerPool::CreateForCurrentThread("Pool 12");
+
+	auto timer17 = TimerPool::Timer::Create(pool12, "DELTA");
+	timer17->setCallback(kPrintTimerCallback);
+	timer17->setInterval(std::chrono::milliseconds(500));
+	timer17->setRepeated(true);
+	timer17->start();
+
+	const auto endTime = TimerPool::Clock::now() + std::chrono::seconds(10);
+
+	while (TimerPool::Clock::now() < endTime)
+		std::this_thread::sleep_until(std::min(pool12->poll(), endTime));
 }